@@ -0,0 +1,493 @@
+#include <string>
+#include <string_view>
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+
+#include <util.hpp>
+#include <tinge.hpp>
+
+
+// Just enough JSON to read nanobench's json template back in.
+namespace json {
+	#define TOKENS \
+		X(TOKEN_NONE) \
+		X(TOKEN_EOF) \
+		X(TOKEN_LBRACE) \
+		X(TOKEN_RBRACE) \
+		X(TOKEN_LBRACKET) \
+		X(TOKEN_RBRACKET) \
+		X(TOKEN_COLON) \
+		X(TOKEN_COMMA) \
+		X(TOKEN_STRING) \
+		X(TOKEN_SCALAR)
+
+	#define X(x) #x,
+		const char* to_str[] = { TOKENS };
+	#undef X
+
+	#define X(x) x,
+		enum { TOKENS };
+	#undef X
+
+	#undef TOKENS
+
+
+	// Strings are returned without their quotes and with escapes left
+	// as they are, numbers and literals as scalars.
+	inline util::Token next_token(const char*& ptr) {
+		util::Token tok{{ptr, 1}, TOKEN_NONE};
+
+		auto& [view, type] = tok;
+		auto& [vbegin, vend] = view;
+
+		if (*ptr == '\0') {
+			type = TOKEN_EOF;
+		}
+
+		else if (util::is_whitespace(*ptr) or *ptr == '\r') {
+			do {
+				++ptr;
+			} while (util::is_whitespace(*ptr) or *ptr == '\r');
+
+			return next_token(ptr);
+		}
+
+		else if (*ptr == '{') { type = TOKEN_LBRACE; ++ptr; }
+		else if (*ptr == '}') { type = TOKEN_RBRACE; ++ptr; }
+		else if (*ptr == '[') { type = TOKEN_LBRACKET; ++ptr; }
+		else if (*ptr == ']') { type = TOKEN_RBRACKET; ++ptr; }
+		else if (*ptr == ':') { type = TOKEN_COLON; ++ptr; }
+		else if (*ptr == ',') { type = TOKEN_COMMA; ++ptr; }
+
+		else if (*ptr == '"') {
+			type = TOKEN_STRING;
+			vbegin = ++ptr;
+
+			while (*ptr != '"' and *ptr != '\0') {
+				if (*ptr == '\\' and *(ptr + 1) != '\0')
+					++ptr;
+
+				++ptr;
+			}
+
+			vend = ptr - vbegin;
+
+			if (*ptr == '"')
+				++ptr;
+
+			return tok;
+		}
+
+		else {
+			type = TOKEN_SCALAR;
+
+			do {
+				++ptr;
+			} while (*ptr != '\0' and not util::is_whitespace(*ptr) and not util::in_group(*ptr, ',', ':', ']', '}'));
+		}
+
+		vend = ptr - vbegin;
+
+		return tok;
+	}
+}
+
+
+namespace json {
+	struct Object {
+		std::vector<std::pair<util::View, util::Node>> members;
+	};
+
+	struct Array {
+		std::vector<util::Node> elements;
+	};
+
+	struct Scalar {
+		util::Token tok;
+	};
+
+	using AST = util::AST<Object, Array, Scalar>;
+	using Lexer = util::Lexer<json::next_token>;
+
+
+	inline util::Node value(json::Lexer& lex, json::AST& tree) {
+		util::Token tok = lex.advance();
+
+		if (tok == TOKEN_STRING or tok == TOKEN_SCALAR)
+			return tree.add<Scalar>(tok);
+
+		if (tok == TOKEN_LBRACKET) {
+			std::vector<util::Node> elements;
+
+			while (lex.peek() != TOKEN_RBRACKET and lex.peek() != TOKEN_EOF) {
+				elements.emplace_back(value(lex, tree));
+
+				if (lex.peek() == TOKEN_COMMA)
+					lex.advance();
+			}
+
+			if (lex.advance() != TOKEN_RBRACKET) {
+				std::cerr << "expected closing bracket\n";
+				std::exit(-1);
+			}
+
+			return tree.add<Array>(std::move(elements));
+		}
+
+		if (tok == TOKEN_LBRACE) {
+			std::vector<std::pair<util::View, util::Node>> members;
+
+			while (lex.peek() == TOKEN_STRING) {
+				util::View key = lex.advance().view;
+
+				if (lex.advance() != TOKEN_COLON) {
+					std::cerr << "expected colon\n";
+					std::exit(-1);
+				}
+
+				members.emplace_back(key, value(lex, tree));
+
+				if (lex.peek() == TOKEN_COMMA)
+					lex.advance();
+			}
+
+			if (lex.advance() != TOKEN_RBRACE) {
+				std::cerr << "expected closing brace\n";
+				std::exit(-1);
+			}
+
+			return tree.add<Object>(std::move(members));
+		}
+
+		std::cerr << "expected a value\n";
+		std::exit(-1);
+	}
+
+
+	// Member `key` of object `n`, or NODE_EMPTY.
+	inline util::Node find(const json::AST& tree, util::Node n, std::string_view key) {
+		if (n == util::NODE_EMPTY or not std::holds_alternative<Object>(tree[n]))
+			return util::NODE_EMPTY;
+
+		for (const auto& [k, v]: std::get<Object>(tree[n]).members) {
+			if (std::string_view{ k.begin, static_cast<std::size_t>(k.length) } == key)
+				return v;
+		}
+
+		return util::NODE_EMPTY;
+	}
+
+	inline std::string string(const json::AST& tree, util::Node n) {
+		if (n == util::NODE_EMPTY or not std::holds_alternative<Scalar>(tree[n]))
+			return {};
+
+		return std::get<Scalar>(tree[n]).tok.str();
+	}
+
+	inline double number(const json::AST& tree, util::Node n) {
+		return std::strtod(string(tree, n).c_str(), nullptr);
+	}
+
+	inline const std::vector<util::Node>& elements(const json::AST& tree, util::Node n) {
+		static const std::vector<util::Node> none;
+
+		if (n == util::NODE_EMPTY or not std::holds_alternative<Array>(tree[n]))
+			return none;
+
+		return std::get<Array>(tree[n]).elements;
+	}
+}
+
+
+// Results.
+/*
+	nanobench reports `elapsed` per iteration, every statistic here is
+	divided by the batch size to get time per unit so results from runs
+	with different batch sizes still line up.
+*/
+namespace benchcmp {
+	struct Result {
+		std::string title;
+		std::string name;
+		std::string unit;
+
+		double median = 0.0;  // seconds per unit
+		double error = 0.0;   // median absolute percent error, as a fraction
+
+		// Quartiles of the per-epoch measurements.
+		double p25 = 0.0;
+		double p75 = 0.0;
+	};
+
+	inline double percentile(std::vector<double> xs, double p) {
+		if (xs.empty())
+			return 0.0;
+
+		std::sort(xs.begin(), xs.end());
+
+		const double pos = p * static_cast<double>(xs.size() - 1);
+		const auto lo = static_cast<std::size_t>(pos);
+		const auto hi = std::min(lo + 1, xs.size() - 1);
+
+		return xs[lo] + (xs[hi] - xs[lo]) * (pos - static_cast<double>(lo));
+	}
+
+	inline bool load(const std::string& fname, std::vector<Result>& results) {
+		std::error_code ec;
+
+		if (not std::filesystem::exists(fname, ec)) {
+			tinge::errorln("no such file: ", fname);
+			return false;
+		}
+
+		const std::string str = util::read_file(fname);
+
+		json::AST tree;
+		json::Lexer lex{str.c_str()};
+
+		const util::Node root = json::value(lex, tree);
+		const util::Node list = json::find(tree, root, "results");
+
+		if (list == util::NODE_EMPTY) {
+			tinge::errorln("not a nanobench json file: ", fname);
+			return false;
+		}
+
+		for (util::Node n: json::elements(tree, list)) {
+			Result r;
+
+			r.title = json::string(tree, json::find(tree, n, "title"));
+			r.name = json::string(tree, json::find(tree, n, "name"));
+			r.unit = json::string(tree, json::find(tree, n, "unit"));
+
+			const double batch = std::max(json::number(tree, json::find(tree, n, "batch")), 1.0);
+
+			r.median = json::number(tree, json::find(tree, n, "median(elapsed)")) / batch;
+			r.error = json::number(tree, json::find(tree, n, "medianAbsolutePercentError(elapsed)"));
+
+			std::vector<double> xs;
+
+			for (util::Node m: json::elements(tree, json::find(tree, n, "measurements")))
+				xs.push_back(json::number(tree, json::find(tree, m, "elapsed")) / batch);
+
+			r.p25 = percentile(xs, 0.25);
+			r.p75 = percentile(xs, 0.75);
+
+			results.push_back(std::move(r));
+		}
+
+		return true;
+	}
+}
+
+
+// Comparison.
+/*
+	A change only counts when it is larger than the threshold and both
+	the error bounds around the two medians and their interquartile
+	ranges are disjoint. Noisy results are reported as unchanged rather
+	than failing the run.
+
+	Benchmarks in the baseline that the new run lacks fail the comparison
+	too, unless they are explicitly allowed to be missing, so that
+	deleting a slow benchmark doesn't pass the gate. New benchmarks are
+	only listed.
+*/
+namespace benchcmp {
+	enum {
+		VERDICT_SAME,
+		VERDICT_FASTER,
+		VERDICT_SLOWER,
+		VERDICT_NEW,
+		VERDICT_MISSING,
+	};
+
+	inline int verdict(const Result& base, const Result& cur, double threshold) {
+		const double change = cur.median / base.median - 1.0;
+
+		if (
+			change > threshold and
+			cur.median * (1.0 - cur.error) > base.median * (1.0 + base.error) and
+			cur.p25 > base.p75
+		)
+			return VERDICT_SLOWER;
+
+		if (
+			change < -threshold and
+			cur.median * (1.0 + cur.error) < base.median * (1.0 - base.error) and
+			cur.p75 < base.p25
+		)
+			return VERDICT_FASTER;
+
+		return VERDICT_SAME;
+	}
+
+	// Returns the number of significant regressions, counting missing
+	// benchmarks unless `allow_missing` is set.
+	inline int compare(const std::vector<Result>& base, const std::vector<Result>& cur, double threshold, bool allow_missing) {
+		constexpr const char* labels[] = { "same", "faster", "SLOWER", "new", "MISSING" };
+
+		auto same_benchmark = [] (const Result& a, const Result& b) {
+			return a.title == b.title and a.name == b.name;
+		};
+
+		int slower = 0, faster = 0, missing = 0;
+
+		std::printf("%-8s %9s %12s %12s %7s  %s\n", "", "change", "base", "new", "err", "benchmark");
+
+		for (const Result& c: cur) {
+			auto it = std::find_if(base.begin(), base.end(), [&] (const Result& b) {
+				return same_benchmark(b, c);
+			});
+
+			const std::string label = c.title + " / " + c.name;
+
+			if (it == base.end()) {
+				std::printf("%-8s %9s %12s %12.3f %6.1f%%  %s\n",
+					labels[VERDICT_NEW], "", "", c.median * 1e9, c.error * 100.0, label.c_str());
+				continue;
+			}
+
+			const int v = verdict(*it, c, threshold);
+
+			slower += v == VERDICT_SLOWER;
+			faster += v == VERDICT_FASTER;
+
+			std::printf("%-8s %+8.1f%% %12.3f %12.3f %6.1f%%  %s\n",
+				labels[v], (c.median / it->median - 1.0) * 100.0, it->median * 1e9, c.median * 1e9,
+				std::max(c.error, it->error) * 100.0, label.c_str());
+		}
+
+		for (const Result& b: base) {
+			const bool found = std::any_of(cur.begin(), cur.end(), [&] (const Result& c) {
+				return same_benchmark(b, c);
+			});
+
+			if (found)
+				continue;
+
+			missing++;
+
+			const std::string label = b.title + " / " + b.name;
+
+			std::printf("%-8s %9s %12.3f %12s %6.1f%%  %s\n",
+				labels[VERDICT_MISSING], "", b.median * 1e9, "", b.error * 100.0, label.c_str());
+		}
+
+		std::printf("(times in ns per unit)\n");
+
+		if (slower > 0)
+			tinge::errorln(slower, " of ", cur.size(), " benchmarks are significantly slower");
+
+		if (missing > 0 and not allow_missing)
+			tinge::errorln(missing, " baseline benchmarks are missing from the new run, pass --allow-missing if that is intended");
+
+		else if (missing > 0)
+			tinge::warnln(missing, " baseline benchmarks are missing from the new run");
+
+		if (slower == 0 and (missing == 0 or allow_missing))
+			tinge::successln("no significant regressions in ", cur.size(), " benchmarks (", faster, " faster)");
+
+		return slower + (allow_missing ? 0 : missing);
+	}
+}
+
+
+namespace benchcmp {
+	inline std::string path(const std::string& dir, const std::string& name) {
+		return dir + "/" + name + ".json";
+	}
+
+	// Baselines are kept as the unmodified nanobench output.
+	inline bool save(const std::string& dir, const std::string& name, const std::string& fname) {
+		std::vector<Result> results;
+
+		if (not load(fname, results))
+			return false;
+
+		std::error_code ec;
+		std::filesystem::create_directories(dir, ec);
+
+		std::string str = util::read_file(fname);
+		str.pop_back();
+
+		std::ofstream os(path(dir, name), std::ios::binary | std::ios::trunc);
+		os.write(str.data(), static_cast<std::streamsize>(str.size()));
+
+		if (not os) {
+			tinge::errorln("unable to write baseline: ", path(dir, name));
+			return false;
+		}
+
+		tinge::successln("saved ", results.size(), " results as '", name, "'");
+		return true;
+	}
+
+	inline void list(const std::string& dir) {
+		std::error_code ec;
+
+		for (const auto& entry: std::filesystem::directory_iterator(dir, ec)) {
+			if (entry.path().extension() == ".json")
+				std::cout << entry.path().stem().string() << '\n';
+		}
+	}
+}
+
+
+int main(int argc, const char* argv[]) {
+	constexpr const char* usage =
+		"usage: benchcmp [--dir <path>] save <name> <results.json>\n"
+		"       benchcmp [--dir <path>] [--threshold <percent>] [--allow-missing] compare <name> <results.json>\n"
+		"       benchcmp [--dir <path>] list\n";
+
+	std::string dir = "baselines";
+	double threshold = 0.05;
+	bool allow_missing = false;
+
+	std::vector<std::string_view> args;
+
+	for (int i = 1; i < argc; i++) {
+		std::string_view arg = argv[i];
+
+		if (arg == "--dir" and i + 1 < argc)
+			dir = argv[++i];
+
+		else if (arg == "--threshold" and i + 1 < argc)
+			threshold = std::strtod(argv[++i], nullptr) / 100.0;
+
+		else if (arg == "--allow-missing")
+			allow_missing = true;
+
+		else
+			args.push_back(arg);
+	}
+
+	if (args.size() == 1 and args[0] == "list") {
+		benchcmp::list(dir);
+		return 0;
+	}
+
+	if (args.size() != 3 or (args[0] != "save" and args[0] != "compare")) {
+		std::cerr << usage;
+		return -1;
+	}
+
+	const std::string name{args[1]};
+	const std::string fname{args[2]};
+
+	if (args[0] == "save")
+		return benchcmp::save(dir, name, fname) ? 0 : -1;
+
+	std::vector<benchcmp::Result> base, cur;
+
+	if (not benchcmp::load(benchcmp::path(dir, name), base) or not benchcmp::load(fname, cur))
+		return -1;
+
+	return benchcmp::compare(base, cur, threshold, allow_missing) > 0 ? 1 : 0;
+}
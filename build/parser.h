@@ -0,0 +1,79 @@
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <stddef.h>
+
+
+// Embedding API.
+/*
+	C interface to the calculator and graph parsers, built by lib/ as
+	libparser.a and libparser.so.
+
+	Input is a NUL-terminated buffer owned by the caller. Parsing doesn't
+	copy it: the tree refers back into it, so it has to stay alive and
+	unchanged until the next parse or until the context is destroyed.
+	Results are written into memory owned by the caller.
+
+	A context keeps its tree and scratch buffers between calls, so parsing
+	many small inputs with the same context allocates nothing once it has
+	grown to fit. Contexts aren't thread safe, but separate contexts can
+	be used from separate threads.
+
+	Functions returning text follow snprintf(3): at most `size - 1` bytes
+	and a terminating NUL are written to `buf`, and the full length is
+	returned so that a caller can retry with a bigger buffer. `buf` may be
+	NULL when `size` is 0.
+
+	Malformed input makes parse return -1, after which the context is
+	empty and the error function describes what went wrong.
+*/
+#if defined(__GNUC__)
+	#define PARSER_API __attribute__((visibility("default")))
+#else
+	#define PARSER_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct parser_calc parser_calc;
+
+PARSER_API parser_calc* parser_calc_create(void);
+PARSER_API void parser_calc_destroy(parser_calc* ctx);
+
+// Number of expressions in `input`, or -1 on error.
+PARSER_API long parser_calc_parse(parser_calc* ctx, const char* input);
+
+// Evaluates the first `n` expressions into `out` and returns how many
+// were written.
+PARSER_API size_t parser_calc_eval(parser_calc* ctx, double* out, size_t n);
+
+// Writes expression `i` fully parenthesised.
+PARSER_API size_t parser_calc_print(parser_calc* ctx, size_t i, char* buf, size_t size);
+
+// Message for the last failed parse, or NULL.
+PARSER_API const char* parser_calc_error(const parser_calc* ctx);
+
+
+typedef struct parser_graph parser_graph;
+
+PARSER_API parser_graph* parser_graph_create(void);
+PARSER_API void parser_graph_destroy(parser_graph* ctx);
+
+// Number of lists in `input`, or -1 on error.
+PARSER_API long parser_graph_parse(parser_graph* ctx, const char* input);
+
+// Writes every list as one Graphviz digraph.
+PARSER_API size_t parser_graph_render(parser_graph* ctx, char* buf, size_t size);
+
+// Message for the last failed parse, or NULL.
+PARSER_API const char* parser_graph_error(const parser_graph* ctx);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif